@@ -8,26 +8,100 @@
  *      Lovina, John Melrick M.
 */
 
+// Feature macros; must come before the header files
+#define _POSIX_C_SOURCE 200809L // For clock_gettime and fseeko
+#define _FILE_OFFSET_BITS 64 // 64-bit off_t on 32-bit systems
+
 // Header files
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include <setjmp.h>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h> // For GetTickCount64
+#endif
+
+// Seeks with 64-bit offsets, so index files over 2 GiB can be searched
+#ifdef _WIN32
+#define fseek64 _fseeki64
+#else
+#define fseek64 fseeko
+#endif
+
+#define DIFFERENT_EXIT_CODE 1 // Exit code of --compare when the expressions differ
+#define INVALID_EXIT_CODE 2 // Exit code of --compare when an expression or argument is invalid
+#define LIMIT_EXIT_CODE 3 // Exit code when a resource limit is exceeded
 
 // Defines a binary node with left and right child
 typedef struct Node {
     char data;
     struct Node *left, *right;
+    unsigned long long hash; // Structural hash of the subtree; set by hash_Tree
 } Node;
 
-// Points to next node; used in postfix_to_tree function
+// Points to next node; used as the operator stack in the infix conversions
 typedef struct Stack {
     Node *treeNode;
     struct Stack *next;
 } Stack;
 
+// One record of the subexpression index: a subtree hash and the expression containing it
+typedef struct IndexEntry {
+    unsigned long long hash;
+    unsigned long long id; // Line number of the expression in the corpus
+} IndexEntry;
+
+// Header at the start of an index file, followed by count entries sorted by hash
+typedef struct IndexHeader {
+    char magic[4]; // "NCIX"
+    unsigned int commutative; // Whether + and * operands were put in canonical order
+    unsigned long long count; // Number of entries
+} IndexHeader;
+
+// Resource limits for untrusted input; 0 means unlimited
+typedef struct Limits {
+    long maxBytes; // Input length in bytes
+    long maxTokens; // Operands, operators and parentheses
+    long maxNodes; // Tree (and stack) nodes allocated
+    long maxDepth; // Depth of the expression tree
+    long maxMillis; // Wall-clock time per expression
+} Limits;
+
+// Header in front of every block allocated for an expression
+// The blocks are linked both ways, so one can be freed alone or all released after a limit is hit
+typedef struct Block {
+    struct Block *prev, *next;
+} Block;
+
+static Limits limits = {0, 0, 0, 0, 0};
+static long nodesUsed = 0; // Nodes allocated for the current expression
+static long ticks = 0; // Work counter; the clock is only read every few thousand ticks
+static long long startTime; // When the current expression started, in milliseconds
+static jmp_buf budgetExit; // Set by each caller of startBudget; an exceeded limit jumps back there
+static const char* limitReason; // Which limit was exceeded
+static Block* blocks = NULL; // Blocks of the expressions being processed
+
 // Function prototypes
 int isValidFormat(const char *format); // Validates the format specifier
+const char* nextFormat(const char *formats, char *item, int size); // Splits the next specifier off a format list
+int isValidFormatList(const char *formats); // Validates a comma-separated list of format specifiers
 int isValidExpression(const char *format, char *expression); // Validates the expression based on the format
+int parseOptions(int argc, char* argv[], int first, int* simplify, int* commutative); // Parses optional flags
+int parseLimit(const char* option, const char* value); // Parses a resource limit option
+void limitExceeded(const char* what); // Abandons the current expression when a limit is exceeded
+long long wallMillis(); // Reads a monotonic wall clock in milliseconds
+void startBudget(const char* expression); // Resets usage and checks input size for a new expression
+void checkTime(); // Aborts once the expression has used up its time
+void chargeNode(); // Counts one allocated node against the node limit
+void* budgetAlloc(size_t size); // Allocates memory that is released if the expression is abandoned
+void budgetFree(void* ptr); // Frees memory from budgetAlloc
+void releaseBudget(); // Frees everything still allocated for abandoned expressions
+void checkDepth(long depth); // Aborts if a tree is nested deeper than allowed
+void checkTreeDepth(Node* root, long depth); // Checks the depth of a built tree without deep recursion
+int* newDepthStack(const char* expression); // Allocates a depth stack when --max-depth is set
+void trackDepth(int* depths, int* count, char token); // Tracks tree depth of shunting-yard output
 Node* newNode(char op); // Creates new binary node
 void push(Stack** top, Node* node); // Pushes a tree node onto the stack
 Node* pop(Stack** top); // Pops a tree node from the stack
@@ -36,21 +110,48 @@ int isOperator(char ch); // Checks if the character is an operator
 int isASpace(char ch); // Checks if the character is a space
 void skipSpaces(char* expr, int* index); // Function to skip spaces
 int precedence(char op); // Determines operator precedence
-void inorder_Traversal(Node* root); // Traverses expression in inorder
-void preorder_Traversal(Node* root); // Traverses expression in preorder
-void postorder_Traversal(Node* root); // Traverses expression in postorder
+void countNodes(Node* root, int* operands, int* operators); // Counts operand and operator nodes
+int traversalLength(Node* root, const char* format); // Computes exact output length of a traversal
+char* inorder_Traversal(Node* root, char* out); // Traverses expression in inorder
+char* preorder_Traversal(Node* root, char* out); // Traverses expression in preorder
+char* postorder_Traversal(Node* root, char* out); // Traverses expression in postorder
+int printTraversal(Node* root, const char* format); // Writes a traversal of the tree in the given notation
+void fused_Traversal(Node* root, char** in, char** pre, char** post); // Writes all three traversals in one walk
+int printRecord(Node* root, const char* formats); // Prints every listed notation of the tree as one record
 int isInfix(const char* infix); // Determines whether it is a valid infix
-void infix_to_postfix(const char* infix, char* postfix); // Converts infix to postfix expression
-void infix_to_prefix(const char* infix, char* prefix); // Converts infix to prefix
+int infix_to_postfix(const char* infix, char* postfix); // Converts infix to postfix expression
+int infix_to_prefix(const char* infix, char* prefix); // Converts infix to prefix
 void reverse(char* str); // Reverses a string (used for infix to prefix conversion)
+int checkInfix(const char* infix); // Validates infix input and prints the error if invalid
+void reduce(Stack** operands, Stack** operators); // Combines the top operator with its two operands
+Node* infix_to_tree(const char* infix); // Puts the infix expression in a binary tree
 int isPrefix(const char* prefix); // Determines whether the expression is valid prefix
 Node* prefix_to_tree(char* prefix, int* index); // Puts the prefix expression in a binary tree
-void prefix_to_infix(char *expression); // Function to convert prefix expression to infix expression
-void prefix_to_postfix(char * expression); // Function to convert prefix expression to postfix expression
+Node* build_prefix_tree(char* prefix, int* index, int level); // Builds the tree of a validated prefix expression
+int prefix_to_infix(char *expression); // Function to convert prefix expression to infix expression
+int prefix_to_postfix(char * expression); // Function to convert prefix expression to postfix expression
 int isPostfix(const char* postfix); // Determines whether the expression is valid postfix
 Node* postfix_to_tree(char* postfix); // Puts the postfix expression in a binary tree
-void postfix_to_infix(char *expression); // Function to convert postfix expression to infix expression
-void postfix_to_prefix(char *expression); // Function to convert postfix expression to prefix expression
+int postfix_to_infix(char *expression); // Function to convert postfix expression to infix expression
+int postfix_to_prefix(char *expression); // Function to convert postfix expression to prefix expression
+Node* expression_to_tree(const char* format, char* expression); // Builds the tree for any input format
+int treeEquals(Node* a, Node* b); // Checks if two subtrees are identical
+int isConstant(Node* node, int value); // Checks if the node is the given digit constant
+Node* makeConstant(Node* node, int value); // Rewrites the node into a digit constant leaf
+Node* simplify_Tree(Node* root, int* mayFail); // Folds constants and applies algebraic identities
+Node* simplifyWithStats(Node* root); // Simplifies the tree and reports node counts
+void freeTree(Node* root, const char* format); // Frees a tree built from the given input format
+unsigned long long hash_Tree(Node* root, int commutative); // Computes structural hashes bottom-up
+Node* firstDifference(Node* a, Node* b, Node** other); // Finds the first differing subtree of two hashed trees
+int compareExpressions(const char* format1, char* expr1, const char* format2, char* expr2, int commutative); // Compares two expressions
+char* readLine(FILE* file); // Reads a whole line of any length
+int compareBatch(const char* filename, int commutative); // Compares every pair listed in a file
+int addIndexEntries(Node* root, unsigned long long id, IndexEntry** entries, long* count, long* capacity); // Records every subtree hash
+int compareIndexEntries(const void* a, const void* b); // Orders index entries by hash, then id
+int indexExpression(const char* format, char* expression, unsigned long long id, int commutative,
+                    IndexEntry** entries, long* count, long* capacity); // Records the subtrees of one expression
+int buildIndex(const char* corpusFile, const char* indexFile, int commutative); // Indexes every subtree of a corpus
+int queryIndex(const char* indexFile, const char* format, char* pattern); // Lists expressions containing a pattern
 void printHelp(); // Prints help information
 void printGuide(); // Prints detailed guide with explanations and examples
 
@@ -67,15 +168,60 @@ int main(int argc, char *argv[]) {
         return 0;
     }
     
+    // Equivalence checks
+    int commutative = 0;
+    if (argc >= 2 && strcmp(argv[1], "--compare") == 0) {
+        if (argc < 6) printf("Error: Invalid arguments for '--compare'.\n");
+        if (argc < 6 || !parseOptions(argc, argv, 6, NULL, &commutative)) {
+            printf("Usage: %s --compare <format1> \"<expression1>\" <format2> \"<expression2>\" [options]\n", argv[0]);
+            printf("Try '%s --help' for more information.\n", argv[0]);
+            return INVALID_EXIT_CODE;
+        }
+        int result = compareExpressions(argv[2], argv[3], argv[4], argv[5], commutative);
+        if (result == -2) return LIMIT_EXIT_CODE;
+        if (result < 0) return INVALID_EXIT_CODE;
+        return result ? 0 : DIFFERENT_EXIT_CODE;
+    } else if (argc >= 2 && strcmp(argv[1], "--compare-batch") == 0) {
+        if (argc < 3) printf("Error: Invalid arguments for '--compare-batch'.\n");
+        if (argc < 3 || !parseOptions(argc, argv, 3, NULL, &commutative)) {
+            printf("Usage: %s --compare-batch <file> [options]\n", argv[0]);
+            printf("Try '%s --help' for more information.\n", argv[0]);
+            return INVALID_EXIT_CODE;
+        }
+        return compareBatch(argv[2], commutative);
+    }
+
+    // Subexpression index
+    if (argc >= 2 && strcmp(argv[1], "--index") == 0) {
+        if (argc < 4) printf("Error: Invalid arguments for '--index'.\n");
+        if (argc < 4 || !parseOptions(argc, argv, 4, NULL, &commutative)) {
+            printf("Usage: %s --index <corpus_file> <index_file> [options]\n", argv[0]);
+            printf("Try '%s --help' for more information.\n", argv[0]);
+            return 1;
+        }
+        return buildIndex(argv[2], argv[3], commutative);
+    } else if (argc >= 2 && strcmp(argv[1], "--query") == 0) {
+        if (argc < 5) printf("Error: Invalid arguments for '--query'.\n");
+        if (argc < 5 || !parseOptions(argc, argv, 5, NULL, NULL)) {
+            printf("Usage: %s --query <index_file> <format> \"<pattern>\" [options]\n", argv[0]);
+            printf("Try '%s --help' for more information.\n", argv[0]);
+            return 1;
+        }
+        return queryIndex(argv[2], argv[3], argv[4]);
+    }
+
     // Check for argument count
     if (argc < 6) {
         printf("Error: Missing required arguments.\n");
-        printf("Usage: %s --from <input_format> --to <output_format> \"<expression>\"\n", argv[0]);
+        printf("Usage: %s --from <input_format> --to <output_format> \"<expression>\" [options]\n", argv[0]);
         printf("Try '%s --help' for more information.\n", argv[0]);
         return 1;
-    } else if (argc > 6) {
-        printf("Error: Too many arguments provided.\n");
-        printf("Usage: %s --from <input_format> --to <output_format> \"<expression>\"\n", argv[0]);
+    }
+
+    // Optional flags follow the expression
+    int simplify = 0;
+    if (!parseOptions(argc, argv, 6, &simplify, NULL)) {
+        printf("Usage: %s --from <input_format> --to <output_format> \"<expression>\" [options]\n", argv[0]);
         printf("Try '%s --help' for more information.\n", argv[0]);
         return 1;
     }
@@ -95,7 +241,7 @@ int main(int argc, char *argv[]) {
     char *expression = argv[5];             // Expression to convert
     
     // Validate format specifiers
-    if (!isValidFormat(input_format) && !isValidFormat(output_format)) {
+    if (!isValidFormat(input_format) && !isValidFormatList(output_format)) {
         printf("Error: Invalid format specifiers '%s' and '%s'.\n", input_format, output_format);
         printf("Hint: Use 'infix', 'prefix', or 'postfix'.\n");
         return 1;
@@ -103,12 +249,39 @@ int main(int argc, char *argv[]) {
         printf("Error: Invalid format specifier '%s'.\n", input_format);
         printf("Hint: Use 'infix', 'prefix', or 'postfix'.\n");
         return 1;
-    } else if (!isValidFormat(output_format)) {
+    } else if (!isValidFormatList(output_format)) {
         printf("Error: Invalid format specifier '%s'.\n", output_format);
         printf("Hint: Use 'infix', 'prefix', or 'postfix'.\n");
         return 1;
     }
 
+    // Enforce the resource limits from here on; an exceeded limit returns here
+    if (setjmp(budgetExit)) {
+        printf("Error: Resource limit exceeded - %s.\n", limitReason);
+        releaseBudget();
+        return LIMIT_EXIT_CODE;
+    }
+    startBudget(expression);
+
+    // Several output formats share one tree and one fused traversal
+    if (strchr(output_format, ',') != NULL) {
+        Node* tree = expression_to_tree(input_format, expression);
+        if (tree == NULL) return 1;
+        int printed = printRecord(simplify ? simplifyWithStats(tree) : tree, output_format);
+        freeTree(tree, input_format);
+        return printed ? 0 : 1;
+    }
+
+    // Simplify between tree construction and traversal
+    if (simplify) {
+        Node* tree = expression_to_tree(input_format, expression);
+        if (tree == NULL) return 1;
+        int printed = printTraversal(simplifyWithStats(tree), output_format);
+        if (printed) printf("\n");
+        freeTree(tree, input_format); // Subtrees folded away by simplification are released at exit
+        return printed ? 0 : 1;
+    }
+
     // If input and output formats are the same
     if (strcmp(input_format, output_format) == 0) {
         int valid = isValidExpression(input_format, expression);
@@ -124,28 +297,31 @@ int main(int argc, char *argv[]) {
 
     // If input and output formats are different
     // Perform conversions based on input and output formats
+    int converted; // 1 if the conversion succeeded
     if ((strcmp(input_format, "infix") == 0) && (strcmp(output_format, "postfix") == 0)) { // Infix to postfix
-        char postfix[100] = {0};
-        infix_to_postfix(expression, postfix);
+        char* postfix = (char*)budgetAlloc(2 * strlen(expression) + 1); // Room for a space after every token
+        converted = infix_to_postfix(expression, postfix);
+        budgetFree(postfix);
     } else if ((strcmp(input_format, "infix") == 0) && (strcmp(output_format, "prefix") == 0)) { // Infix to prefix
-        char prefix[100] = {0};
-        infix_to_prefix(expression, prefix);
+        char* prefix = (char*)budgetAlloc(2 * strlen(expression) + 1); // Room for a space after every token
+        converted = infix_to_prefix(expression, prefix);
+        budgetFree(prefix);
     } else if ((strcmp(input_format, "prefix") == 0) && (strcmp(output_format, "infix") == 0)) { // Prefix to infix
-        prefix_to_infix(expression);
+        converted = prefix_to_infix(expression);
     } else if ((strcmp(input_format, "postfix") == 0) && (strcmp(output_format, "infix") == 0)) { // Postfix to infix
-        postfix_to_infix(expression);
+        converted = postfix_to_infix(expression);
     } else if ((strcmp(input_format, "postfix") == 0) && (strcmp(output_format, "prefix") == 0)) { // Postfix to prefix
-        postfix_to_prefix(expression);
+        converted = postfix_to_prefix(expression);
     } else if ((strcmp(input_format, "prefix") == 0) && (strcmp(output_format, "postfix") == 0)) { // Prefix to postfix
-        prefix_to_postfix(expression);
+        converted = prefix_to_postfix(expression);
     } else {
         printf("Error: Unsupported format conversion from %s to %s.\n", input_format, output_format);
         printf("Try '%s --help' for more information.\n", argv[0]);
         return 1;
     }
 
-    // Exit program
-    return 0;
+    // Exit program; invalid input exits with 1
+    return converted ? 0 : 1;
 }
 
 // Function to validate format specifier
@@ -155,6 +331,26 @@ int isValidFormat(const char *format) {
            strcmp(format, "postfix") == 0;
 }
 
+// Function to get the next specifier of a comma-separated format list
+// Copies it into item and returns the rest of the list, or NULL if the item is too long
+const char* nextFormat(const char *formats, char *item, int size) {
+    int len = strcspn(formats, ",");
+    if (len >= size) return NULL;
+    memcpy(item, formats, len);
+    item[len] = '\0';
+    return formats[len] == ',' ? formats + len + 1 : formats + len;
+}
+
+// Function to validate a comma-separated list of format specifiers, e.g. "infix,prefix"
+int isValidFormatList(const char *formats) {
+    char item[8];
+    do {
+        formats = nextFormat(formats, item, sizeof item);
+        if (formats == NULL || !isValidFormat(item)) return 0;
+    } while (*formats != '\0');
+    return formats[-1] != ','; // No trailing comma
+}
+
 // Function to check if the expression is valid based on the format
 int isValidExpression(const char *format, char *expression) {
     if (strcmp(format, "infix") == 0) return isInfix(expression);
@@ -163,9 +359,163 @@ int isValidExpression(const char *format, char *expression) {
     return 0;
 }
 
+// Parses the optional flags from argv[first] on; simplify and commutative are NULL where not allowed
+// Prints the error and returns 0 on an unknown option or an invalid limit
+int parseOptions(int argc, char* argv[], int first, int* simplify, int* commutative) {
+    for (int i = first; i < argc; i++) {
+        if (simplify && strcmp(argv[i], "--simplify") == 0) {
+            *simplify = 1;
+        } else if (commutative && strcmp(argv[i], "--commutative") == 0) {
+            *commutative = 1;
+        } else {
+            int parsed = parseLimit(argv[i], i + 1 < argc ? argv[i + 1] : NULL);
+            if (parsed == 0) {
+                printf("Error: Unknown option '%s'.\n", argv[i]);
+                return 0;
+            } else if (parsed < 0) {
+                printf("Error: Option '%s' expects a positive number.\n", argv[i]);
+                return 0;
+            }
+            i++; // Skip the limit value
+        }
+    }
+    return 1;
+}
+
+// Parses a resource limit option and its value
+// Returns 1 on success, 0 if the option is not a limit, -1 if the value is invalid
+int parseLimit(const char* option, const char* value) {
+    long* target = NULL;
+    if (strcmp(option, "--max-bytes") == 0) target = &limits.maxBytes;
+    else if (strcmp(option, "--max-tokens") == 0) target = &limits.maxTokens;
+    else if (strcmp(option, "--max-nodes") == 0) target = &limits.maxNodes;
+    else if (strcmp(option, "--max-depth") == 0) target = &limits.maxDepth;
+    else if (strcmp(option, "--max-time") == 0) target = &limits.maxMillis;
+    if (target == NULL) return 0;
+    if (value == NULL) return -1;
+
+    char* end;
+    long number = strtol(value, &end, 10);
+    if (*value == '\0' || *end != '\0' || number <= 0) return -1;
+    *target = number;
+    return 1;
+}
+
+// Abandons the current expression by jumping back to the caller of startBudget
+// The caller frees the partly built expression with releaseBudget
+void limitExceeded(const char* what) {
+    limitReason = what;
+    longjmp(budgetExit, 1);
+}
+
+// Reads a monotonic wall clock in milliseconds, so time spent waiting for the processor counts too
+long long wallMillis() {
+#ifdef _WIN32
+    return (long long)GetTickCount64();
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (long long)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+#endif
+}
+
+// Resets usage for a new expression and checks its size in one bounded scan
+// The caller must have set budgetExit with setjmp, which returns nonzero if a limit is exceeded
+void startBudget(const char* expression) {
+    nodesUsed = 0;
+    ticks = 0;
+    startTime = wallMillis();
+    if (limits.maxBytes == 0 && limits.maxTokens == 0) return;
+
+    long tokens = 0;
+    for (long i = 0; expression[i] != '\0'; i++) {
+        if (limits.maxBytes && i >= limits.maxBytes) limitExceeded("input too long");
+        if (!isASpace(expression[i]) && limits.maxTokens && ++tokens > limits.maxTokens)
+            limitExceeded("too many tokens");
+    }
+}
+
+// Aborts once the expression has used up its time; cheap enough to call per token or node
+// Every pass over an expression calls it, so the limit covers parsing, rewriting, hashing and output
+void checkTime() {
+    if (limits.maxMillis == 0 || ++ticks % 4096 != 0) return;
+    if (wallMillis() - startTime > limits.maxMillis)
+        limitExceeded("time limit reached");
+}
+
+// Counts one allocated node against the node limit
+void chargeNode() {
+    if (limits.maxNodes && ++nodesUsed > limits.maxNodes) limitExceeded("too many nodes");
+    checkTime();
+}
+
+// Allocates memory for an expression and links it into the block list
+void* budgetAlloc(size_t size) {
+    Block* block = (Block*)malloc(sizeof(Block) + size);
+    if (block == NULL) return NULL;
+    block->prev = NULL;
+    block->next = blocks;
+    if (blocks) blocks->prev = block;
+    blocks = block;
+    return block + 1; // The caller's memory follows the header
+}
+
+// Unlinks a block from the list and frees it
+void budgetFree(void* ptr) {
+    if (ptr == NULL) return;
+    Block* block = (Block*)ptr - 1;
+    if (block->prev) block->prev->next = block->next;
+    else blocks = block->next;
+    if (block->next) block->next->prev = block->prev;
+    free(block);
+}
+
+// Frees every block still allocated, e.g. the partial trees and stacks left behind by limitExceeded
+void releaseBudget() {
+    while (blocks) {
+        Block* next = blocks->next;
+        free(blocks);
+        blocks = next;
+    }
+}
+
+// Aborts if a tree is nested deeper than allowed
+void checkDepth(long depth) {
+    if (limits.maxDepth && depth > limits.maxDepth) limitExceeded("expression nested too deeply");
+}
+
+// Checks the depth of a built tree; recursion stops as soon as the limit is passed
+void checkTreeDepth(Node* root, long depth) {
+    if (limits.maxDepth == 0 || root == NULL) return;
+    checkDepth(depth);
+    checkTreeDepth(root->left, depth + 1);
+    checkTreeDepth(root->right, depth + 1);
+}
+
+// Allocates room for one depth per operand when --max-depth is set, otherwise returns NULL
+int* newDepthStack(const char* expression) {
+    if (limits.maxDepth == 0) return NULL;
+    return (int*)budgetAlloc((strlen(expression) + 1) * sizeof(int));
+}
+
+// Tracks the depth of the tree described by the shunting-yard output, which is never built
+// An operand is a subtree of depth 1; an operator joins the top two subtrees one level up
+void trackDepth(int* depths, int* count, char token) {
+    if (depths == NULL) return;
+    if (isOperator(token)) {
+        int left = depths[*count - 2], right = depths[*count - 1];
+        (*count)--;
+        depths[*count - 1] = 1 + (left > right ? left : right);
+    } else {
+        depths[(*count)++] = 1;
+    }
+    checkDepth(depths[*count - 1]);
+}
+
 // Creates new binary node with the given operator or operand
 Node* newNode(char op) {
-    Node* node = (Node*)malloc(sizeof(Node));
+    chargeNode();
+    Node* node = (Node*)budgetAlloc(sizeof(Node));
     node->data = op;
     node->left = node->right = NULL;
     return node;
@@ -173,7 +523,8 @@ Node* newNode(char op) {
 
 // Pushes a tree node onto the stack
 void push(Stack** top, Node* node) {
-    Stack* newStackNode = (Stack*)malloc(sizeof(Stack));
+    checkTime();
+    Stack* newStackNode = (Stack*)budgetAlloc(sizeof(Stack));
     newStackNode->treeNode = node;
     newStackNode->next = *top;
     *top = newStackNode;
@@ -185,7 +536,7 @@ Node* pop(Stack** top) {
     Stack* temp = *top; // Store current top
     *top = (*top)->next; // Move top to next
     Node* node = temp->treeNode; // Get the tree node
-    free(temp); // Free stack node
+    budgetFree(temp); // Free stack node
     return node; // Return node (caller must free it)
 }
 
@@ -218,38 +569,158 @@ int precedence(char op) {
     return 0;
 }
 
-// Function to traverse in preorder (root, left, right)
-void preorder_Traversal(Node* root) {
+// Counts the operand and operator nodes of a subtree (bottom-up)
+void countNodes(Node* root, int* operands, int* operators) {
+    if (root == NULL) return;
+    checkTime();
+    countNodes(root->left, operands, operators); // Count left
+    countNodes(root->right, operands, operators); // Count right
+    if (isOperator(root->data)) (*operators)++;
+    else (*operands)++;
+}
+
+// Computes the exact number of bytes a traversal of the subtree writes
+int traversalLength(Node* root, const char* format) {
+    int operands = 0, operators = 0;
+    countNodes(root, &operands, &operators);
+    if (strcmp(format, "infix") == 0)
+        return operands + 5 * operators; // "x" per operand, "(", " op " and ")" per operator
+    return 2 * (operands + operators); // "x " per node in prefix and postfix
+}
+
+// Function to traverse in preorder (root, left, right); returns the end of the output
+char* preorder_Traversal(Node* root, char* out) {
     if (root != NULL) { 
-        printf("%c ", root->data); // Visit root
-        preorder_Traversal(root->left); // Traverse left
-        preorder_Traversal(root->right); // Traverse right
+        checkTime();
+        *out++ = root->data; // Visit root
+        *out++ = ' ';
+        out = preorder_Traversal(root->left, out); // Traverse left
+        out = preorder_Traversal(root->right, out); // Traverse right
     }
+    return out;
 }
 
-// Function to traverse in inorder (left, root, right)
-void inorder_Traversal(Node* root) {
+// Function to traverse in inorder (left, root, right); returns the end of the output
+char* inorder_Traversal(Node* root, char* out) {
     if (root == NULL)
-        return;
+        return out;
+    checkTime();
     // If it's an operator, add parentheses
     if (isOperator(root->data)) {
-        printf("(");
-        inorder_Traversal(root->left); // Visit left
-        printf(" %c ", root->data); // Visit root
-        inorder_Traversal(root->right); // Visit right
-        printf(")");
+        *out++ = '(';
+        out = inorder_Traversal(root->left, out); // Visit left
+        *out++ = ' ';
+        *out++ = root->data; // Visit root
+        *out++ = ' ';
+        out = inorder_Traversal(root->right, out); // Visit right
+        *out++ = ')';
     } else {
-        // Operand (leaf node), just print it
-        printf("%c", root->data);
+        // Operand (leaf node), just write it
+        *out++ = root->data;
+    }
+    return out;
+}
+
+// Function to traverse in postorder (left, right, root); returns the end of the output
+char* postorder_Traversal(Node* root, char* out) {
+    if (root == NULL) return out;
+    checkTime();
+    out = postorder_Traversal(root->left, out); // Visit left
+    out = postorder_Traversal(root->right, out); // Visit right
+    *out++ = root->data; // Visit root
+    *out++ = ' ';
+    return out;
+}
+
+// Sizes the output first, fills it in one buffer, then writes it out at once
+// Returns 1 on success, 0 if the buffer cannot be allocated
+int printTraversal(Node* root, const char* format) {
+    int len = traversalLength(root, format);
+    char* output = (char*)budgetAlloc(len + 1); // Released if the walk runs out of time
+    if (output == NULL) {
+        printf("Error: Memory allocation failure.\n");
+        return 0;
     }
+
+    if (strcmp(format, "infix") == 0) inorder_Traversal(root, output);
+    else if (strcmp(format, "prefix") == 0) preorder_Traversal(root, output);
+    else postorder_Traversal(root, output);
+
+    // Prefix and postfix drop their trailing space, as in printRecord and the shunting-yard output
+    if (strcmp(format, "infix") != 0 && len > 0) len--;
+    fwrite(output, 1, len, stdout);
+    budgetFree(output);
+    return 1;
 }
 
-// Function to traverse in postorder (left, right, root)
-void postorder_Traversal(Node* root) {
+// Writes inorder, preorder and postorder output in a single walk
+// Each cursor advances through its own buffer; NULL cursors are skipped
+void fused_Traversal(Node* root, char** in, char** pre, char** post) {
     if (root == NULL) return;
-    postorder_Traversal(root->left); // Visit left
-    postorder_Traversal(root->right); // Visit right
-    printf("%c ", root->data); // Visit root
+    checkTime();
+    int op = isOperator(root->data);
+
+    if (pre) { // Preorder visits root first
+        *(*pre)++ = root->data;
+        *(*pre)++ = ' ';
+    }
+    if (in && op) *(*in)++ = '(';
+    fused_Traversal(root->left, in, pre, post); // Traverse left
+    if (in) { // Inorder visits root between the children
+        if (op) *(*in)++ = ' ';
+        *(*in)++ = root->data;
+        if (op) *(*in)++ = ' ';
+    }
+    fused_Traversal(root->right, in, pre, post); // Traverse right
+    if (in && op) *(*in)++ = ')';
+    if (post) { // Postorder visits root last
+        *(*post)++ = root->data;
+        *(*post)++ = ' ';
+    }
+}
+
+// Prints the tree in every notation of a comma-separated list, one "notation: expression" line each
+// Returns 1 on success, 0 if a buffer cannot be allocated
+int printRecord(Node* root, const char* formats) {
+    char* output[3] = {NULL, NULL, NULL}; // Infix, prefix and postfix buffers
+    const char* names[3] = {"infix", "prefix", "postfix"};
+    char* cursor[3];
+    char item[8];
+
+    // Allocate only the requested notations, each at its exact size
+    const char* rest = formats;
+    do {
+        rest = nextFormat(rest, item, sizeof item);
+        for (int i = 0; i < 3; i++) {
+            if (strcmp(item, names[i]) == 0 && output[i] == NULL) {
+                output[i] = (char*)budgetAlloc(traversalLength(root, names[i]) + 1);
+                if (output[i] == NULL) {
+                    printf("Error: Memory allocation failure.\n");
+                    for (int j = 0; j < 3; j++) budgetFree(output[j]);
+                    return 0;
+                }
+            }
+        }
+    } while (*rest != '\0');
+
+    for (int i = 0; i < 3; i++) cursor[i] = output[i];
+    fused_Traversal(root, output[0] ? &cursor[0] : NULL, output[1] ? &cursor[1] : NULL,
+                    output[2] ? &cursor[2] : NULL);
+
+    // Print in the order requested; prefix and postfix drop their trailing space
+    rest = formats;
+    do {
+        rest = nextFormat(rest, item, sizeof item);
+        for (int i = 0; i < 3; i++) {
+            if (strcmp(item, names[i]) == 0) {
+                int len = cursor[i] - output[i] - (i > 0);
+                printf("%s: %.*s\n", names[i], len, output[i]);
+            }
+        }
+    } while (*rest != '\0');
+
+    for (int i = 0; i < 3; i++) budgetFree(output[i]);
+    return 1;
 }
 
 // Function to determine whether the expression is in valid infix format
@@ -284,17 +755,17 @@ int isInfix(const char* infix) {
     return 0;
 }
 
-// Function to convert from infix to postfix using the Shunting Yard Algorithm
-void infix_to_postfix(const char* infix, char* postfix) {
+// Function to check an infix expression before processing; prints the error and returns 0 if invalid
+int checkInfix(const char* infix) {
     // Check input format before processing
     if (isPostfix(infix) == 1) {
         printf("Error: Malformed expression. Detected postfix format.\n");
         printf("Hint: Expression must be in infix form.\n");
-        return;
+        return 0;
     } else if (isPrefix(infix) == 1) {
         printf("Error: Malformed expression. Detected prefix format.\n");
         printf("Hint: Expression must be in infix form.\n");
-        return;
+        return 0;
     }
 
     // Validate infix expression
@@ -313,16 +784,73 @@ void infix_to_postfix(const char* infix, char* postfix) {
         default:
             printf("Error: Invalid infix expression.\n");
         }
-        return;
+        return 0;
     }
+    return 1;
+}
+
+// Pops an operator and its two operands, then pushes the combined subtree
+void reduce(Stack** operands, Stack** operators) {
+    Node* opNode = pop(operators);
+    opNode->right = pop(operands);
+    opNode->left = pop(operands);
+    push(operands, opNode);
+}
+
+// Function to put the infix expression in a binary tree using the Shunting Yard Algorithm
+Node* infix_to_tree(const char* infix) {
+    if (!checkInfix(infix)) return NULL;
+
+    Stack* operands = NULL; // Stack to hold built subtrees
+    Stack* operators = NULL; // Stack to hold operators and '('
+
+    for (int i = 0; infix[i]; i++) {
+        char token = infix[i];
+        checkTime();
+        // Skip spaces
+        if (isASpace(token)) continue;
+        // If the token is an opening parenthesis, push to operator stack
+        if (token == '(') {
+            push(&operators, newNode(token));
+        // If the token is an operand, it becomes a leaf
+        } else if (isOperand(token)) {
+            push(&operands, newNode(token));
+        // If token is ')', combine subtrees until '(' is found
+        } else if (token == ')') {
+            while (operators && operators->treeNode->data != '(')
+                reduce(&operands, &operators);
+            budgetFree(pop(&operators)); // Remove '(' (isInfix guarantees it exists)
+        // If the token is an operator, combine higher/equal precedence operators first
+        } else if (isOperator(token)) {
+            while (operators && isOperator(operators->treeNode->data) &&
+                   precedence(operators->treeNode->data) >= precedence(token))
+                reduce(&operands, &operators);
+            push(&operators, newNode(token));
+        }
+    }
+    // Combine any remaining operators
+    while (operators)
+        reduce(&operands, &operators);
+    Node* root = pop(&operands);
+    checkTreeDepth(root, 1);
+    return root;
+}
+
+// Function to convert from infix to postfix using the Shunting Yard Algorithm
+int infix_to_postfix(const char* infix, char* postfix) {
+    // Check input format before processing
+    if (!checkInfix(infix)) return 0;
 
     Stack* opStack = NULL; // Stack to hold operators
+    int* depths = newDepthStack(infix); // Depths of the subtrees written so far, for --max-depth
+    int depthCount = 0;
     int j = 0; // Index for postfix output
     int tokenCount = 0; // Track number of tokens to manage spaces
 
     // Traverse the infix expression character by character
     for (int i = 0; infix[i]; i++) {
         char token = infix[i];
+        checkTime();
         // Skip spaces
         if (isASpace(token)) continue;
         // If the token is an opening parenthesis, push to operator stack
@@ -332,6 +860,8 @@ void infix_to_postfix(const char* infix, char* postfix) {
         } else if (isOperand(token)) {
             if (tokenCount > 0) postfix[j++] = ' '; // Add space before token if not first
             postfix[j++] = token;
+            chargeNode(); // Count operands like the tree builders do
+            trackDepth(depths, &depthCount, token);
             tokenCount++;
         // If token is ')', pop from stack to output until '(' is found
         } else if (token == ')') {
@@ -339,27 +869,30 @@ void infix_to_postfix(const char* infix, char* postfix) {
                 printf("Error: Mismatched closing parenthesis.\n");
                 while (opStack) {
                     Node* node = pop(&opStack);
-                    free(node);
+                    budgetFree(node);
                 }
-                return;
+                budgetFree(depths);
+                return 0;
             }
             while (opStack && opStack->treeNode->data != '(') {
                 if (tokenCount > 0) postfix[j++] = ' '; // Add space before operator
                 Node* node = pop(&opStack);
                 postfix[j++] = node->data; // Append popped operator
-                free(node);
+                trackDepth(depths, &depthCount, node->data);
+                budgetFree(node);
                 tokenCount++;
             }
             if (opStack && opStack->treeNode->data == '(') {
                 Node* node = pop(&opStack); // Remove '(' from the stack
-                free(node);
+                budgetFree(node);
             } else {
                 printf("Error: Mismatched closing parenthesis.\n");
                 while (opStack) {
                     Node* node = pop(&opStack);
-                    free(node);
+                    budgetFree(node);
                 }
-                return;
+                budgetFree(depths);
+                return 0;
             }
         // If the token is an operator
         } else if (isOperator(token)) {
@@ -368,7 +901,8 @@ void infix_to_postfix(const char* infix, char* postfix) {
                 if (tokenCount > 0) postfix[j++] = ' '; // Add space before operator
                 Node* node = pop(&opStack);
                 postfix[j++] = node->data; // Append higher/equal precedence operator
-                free(node);
+                trackDepth(depths, &depthCount, node->data);
+                budgetFree(node);
                 tokenCount++;
             }
             push(&opStack, newNode(token));
@@ -379,58 +913,38 @@ void infix_to_postfix(const char* infix, char* postfix) {
         Node* node = pop(&opStack);
         if (tokenCount > 0) postfix[j++] = ' '; // Add space before operator
         postfix[j++] = node->data; // Append remaining operator
-        free(node);
+        trackDepth(depths, &depthCount, node->data);
+        budgetFree(node);
         tokenCount++;
     }
     postfix[j] = '\0'; // Null-terminate the postfix string
     printf("%s\n", postfix); // Print converted expression
+    budgetFree(depths);
+    return 1;
 }
 
 // Function to convert from infix to prefix using the Shunting Yard Algorithm
-void infix_to_prefix(const char* infix, char* prefix) {
+int infix_to_prefix(const char* infix, char* prefix) {
     // Check input format before processing
-    if (isPostfix(infix) == 1) {
-        printf("Error: Malformed expression. Detected postfix format.\n");
-        printf("Hint: Expression must be in infix form.\n");
-        return;
-    } else if (isPrefix(infix) == 1) {
-        printf("Error: Malformed expression. Detected prefix format.\n");
-        printf("Hint: Expression must be in infix form.\n");
-        return;
-    }
-
-    // Validate infix expression
-    int validInfix = isInfix(infix);
-    if (validInfix != 1) {
-        switch (validInfix) {
-        case 0:
-            printf("Error: Invalid character or unbalanced parentheses.\n");
-            break;
-        case 2:
-            printf("Error: Malformed expression. Missing operand.\n");
-            break;
-        case 3:
-            printf("Error: Malformed expression. Missing operator.\n");
-            break;
-        default:
-            printf("Error: Invalid infix expression.\n");
-        }
-        return;
-    }
+    if (!checkInfix(infix)) return 0;
 
     // Reverse the infix expression and swap '(' with ')'
-    char reversed[100] = {0}; // Initialize to avoid garbage data
+    int len = strlen(infix);
+    char* reversed = (char*)budgetAlloc(len + 1); // Sized to the input
     strcpy(reversed, infix);
     reverse(reversed);
 
     // Convert reversed infix to postfix
-    char postfix[100] = {0}; // Initialize to avoid garbage data
+    char* postfix = (char*)budgetAlloc(2 * len + 1); // Room for a space after every token
     Stack* opStack = NULL; // Stack to hold operators
+    int* depths = newDepthStack(infix); // Depths of the subtrees written so far, for --max-depth
+    int depthCount = 0;
     int j = 0; // Index for postfix output
     int tokenCount = 0; // Track number of tokens to manage spaces
 
     for (int i = 0; reversed[i]; i++) {
         char token = reversed[i];
+        checkTime();
         // Skip spaces
         if (isASpace(token)) continue;
         // If the token is an opening parenthesis, push to operator stack
@@ -440,6 +954,8 @@ void infix_to_prefix(const char* infix, char* prefix) {
         } else if (isOperand(token)) {
             if (tokenCount > 0) postfix[j++] = ' '; // Add space before token if not first
             postfix[j++] = token;
+            chargeNode(); // Count operands like the tree builders do
+            trackDepth(depths, &depthCount, token);
             tokenCount++;
         // If token is ')', pop from stack to output until '(' is found
         } else if (token == ')') {
@@ -447,23 +963,30 @@ void infix_to_prefix(const char* infix, char* prefix) {
                 printf("Error: Mismatched closing parenthesis.\n");
                 while (opStack) {
                     Node* node = pop(&opStack);
-                    free(node);
+                    budgetFree(node);
                 }
-                return;
+                budgetFree(reversed);
+                budgetFree(postfix);
+                budgetFree(depths);
+                return 0;
             }
             while (opStack && opStack->treeNode->data != '(') {
                 if (tokenCount > 0) postfix[j++] = ' '; // Add space before operator
                 Node* node = pop(&opStack);
                 postfix[j++] = node->data; // Append popped operator
-                free(node);
+                trackDepth(depths, &depthCount, node->data);
+                budgetFree(node);
                 tokenCount++;
             }
             if (opStack && opStack->treeNode->data == '(') {
                 Node* node = pop(&opStack); // Remove '(' from the stack
-                free(node);
+                budgetFree(node);
             } else {
                 printf("Error: Mismatched closing parenthesis.\n");
-                return;
+                budgetFree(reversed);
+                budgetFree(postfix);
+                budgetFree(depths);
+                return 0;
             }
         // If the token is an operator
         } else if (isOperator(token)) {
@@ -472,7 +995,8 @@ void infix_to_prefix(const char* infix, char* prefix) {
                 if (tokenCount > 0) postfix[j++] = ' '; // Add space before operator
                 Node* node = pop(&opStack);
                 postfix[j++] = node->data; // Append higher precedence operator
-                free(node);
+                trackDepth(depths, &depthCount, node->data);
+                budgetFree(node);
                 tokenCount++;
             }
             push(&opStack, newNode(token));
@@ -483,7 +1007,8 @@ void infix_to_prefix(const char* infix, char* prefix) {
         Node* node = pop(&opStack);
         if (tokenCount > 0) postfix[j++] = ' '; // Add space before operator
         postfix[j++] = node->data; // Append remaining operator
-        free(node);
+        trackDepth(depths, &depthCount, node->data);
+        budgetFree(node);
         tokenCount++;
     }
     postfix[j] = '\0'; // Null-terminate the postfix string
@@ -493,6 +1018,10 @@ void infix_to_prefix(const char* infix, char* prefix) {
     strcpy(prefix, postfix);
     reverse(prefix);
     printf("%s\n", prefix); // Print Print converted expression
+    budgetFree(reversed);
+    budgetFree(postfix);
+    budgetFree(depths);
+    return 1;
 }
 
 // Function to reverse a string and swaps parentheses for infix-to-prefix conversion
@@ -566,53 +1095,71 @@ Node* prefix_to_tree(char* prefix, int* index) {
 
     int validPrefix = isPrefix(prefix);
 
-    // Validate prefix expression
+    // Validate prefix expression once, then build
     if (validPrefix == 1) {
-        skipSpaces(prefix, index); // Skip spaces
-        char token = prefix[*index]; // Read the current character
-
-        if (token == '\0') return NULL; // If token is null terminator, return NULL
-
-        Node* node = newNode(token); // Create a new node with token
-        (*index)++; // Increment index
+        Node* root = build_prefix_tree(prefix, index, 1);
         skipSpaces(prefix, index);
-
-        if (isOperator(token)) { // If token is an operator
-            node->left = prefix_to_tree(prefix, index); // Recursively build left subtree
-            node->right = prefix_to_tree(prefix, index); // Recursively build right subtree
-            if (!node->left || !node->right) { // Check if left or right node is NULL
-                printf("Error: Malformed expression. Incomplete subtree.\n");
-                free(node);
-                return NULL;
-            }
+        if (root != NULL && prefix[*index] != '\0') { // Tokens left over after a complete tree
+            freeTree(root, "prefix");
+            printf("Error: Malformed expression. Missing operator.\n");
+            return NULL;
         }
-        return node; // Return node
+        return root;
     } else if (validPrefix == 2) {
         printf("Error: Malformed expression. Missing operand.\n");
     } else if (validPrefix == 3) {
         printf("Error: Malformed expression. Missing operator.\n");
     } else if(validPrefix == -1)
         printf("Error: Invalid character - prefix notation should not contain parentheses.\n");
+    return NULL;
+}
+
+// Recursively builds the prefix tree after prefix_to_tree has validated the expression
+Node* build_prefix_tree(char* prefix, int* index, int level) {
+    checkDepth(level); // Recursion depth equals tree depth
+    skipSpaces(prefix, index); // Skip spaces
+    char token = prefix[*index]; // Read the current character
+
+    if (token == '\0') return NULL; // If token is null terminator, return NULL
+
+    Node* node = newNode(token); // Create a new node with token
+    (*index)++; // Increment index
+    skipSpaces(prefix, index);
+
+    if (isOperator(token)) { // If token is an operator
+        node->left = build_prefix_tree(prefix, index, level + 1); // Recursively build left subtree
+        node->right = build_prefix_tree(prefix, index, level + 1); // Recursively build right subtree
+        if (!node->left || !node->right) { // Check if left or right node is NULL
+            printf("Error: Malformed expression. Incomplete subtree.\n");
+            budgetFree(node);
+            return NULL;
+        }
+    }
+    return node; // Return node
 }
 
 // Function to convert prefix expression to infix expression
-void prefix_to_infix(char *expression) {
+int prefix_to_infix(char *expression) {
     int index = 0;
     Node* root = prefix_to_tree(expression, &index);
+    int printed = 0;
     if(root != NULL){
-        inorder_Traversal(root);
-        printf("\n");
+        printed = printTraversal(root, "infix");
+        if (printed) printf("\n");
     }
+    return printed;
 }
 
 // Function to convert prefix expression to postfix expression
-void prefix_to_postfix(char * expression) {
+int prefix_to_postfix(char * expression) {
     int index = 0;
     Node* root = prefix_to_tree(expression, &index);
+    int printed = 0;
     if(root != NULL){
-        postorder_Traversal(root);
-        printf("\n");
+        printed = printTraversal(root, "postfix");
+        if (printed) printf("\n");
     }
+    return printed;
 }
 
 // Function to determine whether the expression is in valid postfix format
@@ -637,15 +1184,17 @@ int isPostfix(const char* postfix) {
             return 0; // Invalid character
         }
     }
-    if (operatorCount > operandCount || (operatorCount == 1 && operandCount == 1))
+    // Same rule as postfix_to_tree: exactly one subtree must be left, built by at least one operator
+    if (operandCount == 1 && operatorCount > 0)
         return 1; // The expression is valid
-    else if (operatorCount + 1 > operandCount)
+    else if (operandCount == 0)
         return 2; // Insufficient operand
-    else if (operatorCount < operandCount )
-        return 3; // Insufficient operator
+    return 3; // Insufficient operator
 }
 
 // Function to put the postfix expression in a binary tree
+// Validates and builds in one scan: the running stack depth marks where each
+// operator's operands end, and every node is linked inside one flat array
 Node* postfix_to_tree(char* postfix){
     // Check input format before processing
     if (isInfix(postfix) == 1) {
@@ -658,76 +1207,589 @@ Node* postfix_to_tree(char* postfix){
         return NULL;
     }
 
-    int validPostfix = isPostfix(postfix);
+    int len = strlen(postfix);
+    Node* nodes = (Node*)budgetAlloc((len + 1) * sizeof(Node)); // At most one node per character
+    Node** stack = (Node**)budgetAlloc((len + 1) * sizeof(Node*)); // Subtrees waiting for an operator
+    if (nodes == NULL || stack == NULL) {
+        printf("Error: Memory allocation failure.\n");
+        budgetFree(nodes);
+        budgetFree(stack);
+        return NULL;
+    }
 
-    if(validPostfix == 1){
-        Stack* stack = NULL; // Initialize an empty stack
+    int count = 1; // Nodes used so far; slot 0 is kept for the root
+    int depth = 0; // Running stack depth (operand adds one, operator removes one)
+    int operatorCount = 0;
+    int validPostfix = 1;
 
-        // Loop through each character in the string until null terminator is found
-        for(int i = 0; postfix[i] != '\0'; i++){
-            char token = postfix[i]; // Each character is stored in token variable
-    
-            if(isASpace(token)){ // If token is a space, proceed to next character
-                continue;
-            }
-    
-            if(isOperand(token)){ // If token is an operand, push to stack
-                push(&stack, newNode(token));
-            }
-            if(isOperator(token)){ // If token is an operator, pop two nodes
-                Node* right = pop(&stack);
-                Node* left = pop(&stack);
-                Node* opNode = newNode(token); // Create two children
-                opNode->left = left;
-                opNode->right = right;
-                push(&stack, opNode); // Push the newnode with two children back into the stack
+    for (int i = 0; postfix[i] != '\0'; i++) {
+        char token = postfix[i];
+
+        if (isASpace(token)) continue; // Proceed to next character if space
+
+        if (token == '(' || token == ')') { // Parentheses are not allowed in postfix
+            validPostfix = -1;
+            break;
+        }
+
+        if (isOperand(token)) { // Operand becomes a leaf on top of the stack
+            chargeNode();
+            Node* leaf = &nodes[count++];
+            leaf->data = token;
+            leaf->left = leaf->right = NULL;
+            stack[depth++] = leaf;
+        } else if (isOperator(token)) { // Operator takes the two subtrees below it
+            if (depth < 2) {
+                validPostfix = 2; // Not enough operands
+                break;
             }
+            chargeNode();
+            Node* opNode = &nodes[count++];
+            opNode->data = token;
+            opNode->left = stack[depth - 2];
+            opNode->right = stack[depth - 1];
+            depth--;
+            stack[depth - 1] = opNode;
+            operatorCount++;
+        } else {
+            validPostfix = 0; // Invalid character
+            break;
         }
-        return pop(&stack);
     }
-    else if(validPostfix == 2){
-        printf("Error: Malformed expression. Missing operand.\n");
+
+    if (validPostfix == 1) {
+        if (depth == 0)
+            validPostfix = 2; // Empty expression, insufficient operand
+        else if (depth > 1 || operatorCount == 0)
+            validPostfix = 3; // Operands left over, insufficient operator
     }
-    else if(validPostfix == 3){
-        printf("Error: Malformed expression. Missing operator.\n");
+
+    if (validPostfix == 1) {
+        nodes[0] = *stack[0]; // Move the root to the start of the block
+        budgetFree(stack);
+        checkTreeDepth(&nodes[0], 1);
+        return &nodes[0]; // The whole tree lives in one block headed by the root
     }
-    else if(validPostfix == -1)
+
+    budgetFree(stack);
+    budgetFree(nodes);
+    if (validPostfix == 2) {
+        printf("Error: Malformed expression. Missing operand.\n");
+    } else if (validPostfix == 3) {
+        printf("Error: Malformed expression. Missing operator.\n");
+    } else if (validPostfix == -1) {
         printf("Error: Invalid character - postfix notation should not contain parentheses.\n");
+    } else {
+        printf("Error: Invalid character in postfix expression.\n");
+    }
+    return NULL;
 }
 
 // Function to convert postfix expression to infix expression
-void postfix_to_infix(char *expression) {
+int postfix_to_infix(char *expression) {
     Node* root = postfix_to_tree(expression);
+    int printed = 0;
     if(root != NULL){
-        inorder_Traversal(root);
-        printf("\n");
+        printed = printTraversal(root, "infix");
+        if (printed) printf("\n");
     }
+    return printed;
 }
 
 // Function to convert postfix expression to prefix expression
-void postfix_to_prefix(char *expression) {
+int postfix_to_prefix(char *expression) {
     Node* root = postfix_to_tree(expression);
+    int printed = 0;
     if(root != NULL){
-        preorder_Traversal(root);
-        printf("\n");
+        printed = printTraversal(root, "prefix");
+        if (printed) printf("\n");
+    }
+    return printed;
+}
+
+// Function to build the expression tree for any input format
+Node* expression_to_tree(const char* format, char* expression) {
+    int index = 0;
+    if (strcmp(format, "infix") == 0) return infix_to_tree(expression);
+    if (strcmp(format, "prefix") == 0) return prefix_to_tree(expression, &index);
+    if (strcmp(format, "postfix") == 0) return postfix_to_tree(expression);
+    return NULL;
+}
+
+// Checks whether two subtrees have the same structure and contents
+int treeEquals(Node* a, Node* b) {
+    if (a == NULL || b == NULL) return a == b;
+    checkTime();
+    return a->data == b->data && treeEquals(a->left, b->left) && treeEquals(a->right, b->right);
+}
+
+// Checks if the node is a single-digit constant with the given value
+int isConstant(Node* node, int value) {
+    return node->left == NULL && node->data == '0' + value;
+}
+
+// Turns the node into a single-digit constant leaf, reusing it in place
+Node* makeConstant(Node* node, int value) {
+    node->data = '0' + value;
+    node->left = node->right = NULL;
+    return node;
+}
+
+// Folds constant subtrees and applies safe identities in one bottom-up pass
+// Nodes are rewritten in place; mayFail is set if the subtree can divide by zero
+Node* simplify_Tree(Node* root, int* mayFail) {
+    *mayFail = 0;
+    if (root == NULL || !isOperator(root->data)) return root;
+    checkTime();
+
+    int leftFails = 0, rightFails = 0;
+    Node* left = root->left = simplify_Tree(root->left, &leftFails); // Simplify left
+    Node* right = root->right = simplify_Tree(root->right, &rightFails); // Simplify right
+    char op = root->data;
+
+    // Fold two digit constants when the result is still a single digit
+    if (left->left == NULL && right->left == NULL &&
+        left->data >= '0' && left->data <= '9' && right->data >= '0' && right->data <= '9') {
+        int a = left->data - '0', b = right->data - '0';
+        int result = -1;
+        if (op == '+') result = a + b;
+        else if (op == '-') result = a - b;
+        else if (op == '*') result = a * b;
+        else if (b != 0 && a % b == 0) result = a / b;
+        if (result >= 0 && result <= 9) return makeConstant(root, result);
+    }
+
+    // Identities that drop an operand (x + 0, 0 + x, x - 0, x * 1, 1 * x, x / 1)
+    if ((op == '+' || op == '-') && isConstant(right, 0)) { *mayFail = leftFails; return left; }
+    if (op == '+' && isConstant(left, 0)) { *mayFail = rightFails; return right; }
+    if ((op == '*' || op == '/') && isConstant(right, 1)) { *mayFail = leftFails; return left; }
+    if (op == '*' && isConstant(left, 1)) { *mayFail = rightFails; return right; }
+
+    // Identities that drop a whole subtree are only legal if it cannot divide by zero
+    if (op == '*' && ((isConstant(left, 0) && !rightFails) || (isConstant(right, 0) && !leftFails)))
+        return makeConstant(root, 0); // x * 0, 0 * x
+    if (op == '-' && !leftFails && !rightFails && treeEquals(left, right))
+        return makeConstant(root, 0); // x - x
+
+    *mayFail = leftFails || rightFails ||
+               (op == '/' && !(right->left == NULL && right->data >= '1' && right->data <= '9'));
+    return root;
+}
+
+// Frees a tree built from the given input format
+void freeTree(Node* root, const char* format) {
+    if (root == NULL) return;
+    if (strcmp(format, "postfix") == 0) { // Postfix trees live in one block headed by the root
+        budgetFree(root);
+        return;
+    }
+    freeTree(root->left, format);
+    freeTree(root->right, format);
+    budgetFree(root);
+}
+
+// Computes the structural hash of every subtree bottom-up and stores it in the nodes
+// With commutative set, the operands of '+' and '*' are put in a canonical order first
+unsigned long long hash_Tree(Node* root, int commutative) {
+    if (root == NULL) return 0;
+    checkTime();
+    unsigned long long left = hash_Tree(root->left, commutative); // Hash left
+    unsigned long long right = hash_Tree(root->right, commutative); // Hash right
+
+    if (commutative && (root->data == '+' || root->data == '*') && left > right) {
+        Node* temp = root->left; // Swap so the smaller hash is always on the left
+        root->left = root->right;
+        root->right = temp;
+        unsigned long long tempHash = left;
+        left = right;
+        right = tempHash;
+    }
+
+    // Combine the node with its children, then mix the bits
+    unsigned long long h = (unsigned char)root->data;
+    h = (h * 1099511628211ULL) ^ left;
+    h = (h * 1099511628211ULL) ^ (right * 31);
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    root->hash = h;
+    return h;
+}
+
+// Walks two hashed trees down to the first subtree where they differ
+// Returns that subtree of a and stores the matching subtree of b in other
+Node* firstDifference(Node* a, Node* b, Node** other) {
+    while (a->data == b->data && a->left != NULL && b->left != NULL) {
+        if (a->left->hash != b->left->hash) { // Leftmost difference comes first
+            a = a->left;
+            b = b->left;
+        } else if (a->right->hash != b->right->hash) {
+            a = a->right;
+            b = b->right;
+        } else {
+            break; // Children match, so this node is the difference
+        }
+    }
+    *other = b;
+    return a;
+}
+
+// Parses two expressions in any notations and reports whether they are the same expression
+// Returns 1 if equal, 0 if different, -1 if either expression is invalid or the difference cannot be
+// printed, -2 if a limit is exceeded
+int compareExpressions(const char* format1, char* expr1, const char* format2, char* expr2, int commutative) {
+    if (!isValidFormat(format1) || !isValidFormat(format2)) {
+        printf("Error: Invalid format specifier '%s'.\n", isValidFormat(format1) ? format2 : format1);
+        printf("Hint: Use 'infix', 'prefix', or 'postfix'.\n");
+        return -1;
+    }
+
+    if (setjmp(budgetExit)) {
+        printf("Error: Resource limit exceeded - %s.\n", limitReason);
+        releaseBudget(); // Both trees, finished or not
+        return -2;
+    }
+
+    startBudget(expr1);
+    Node* first = expression_to_tree(format1, expr1);
+    if (first == NULL) return -1;
+    startBudget(expr2);
+    Node* second = expression_to_tree(format2, expr2);
+    if (second == NULL) {
+        freeTree(first, format1);
+        return -1;
     }
+
+    // Equal hashes are confirmed node by node, so a hash collision cannot report Equal
+    int equal = hash_Tree(first, commutative) == hash_Tree(second, commutative) &&
+                treeEquals(first, second);
+    if (equal) {
+        printf("Equal\n");
+    } else {
+        Node* other;
+        Node* diff = firstDifference(first, second, &other);
+        printf("Different: ");
+        int printed = printTraversal(diff, "infix");
+        if (printed) {
+            printf(" vs ");
+            printed = printTraversal(other, "infix");
+        }
+        if (printed) printf("\n");
+        else equal = -1;
+    }
+
+    freeTree(first, format1);
+    freeTree(second, format2);
+    return equal;
+}
+
+// Reads a whole line of any length without the newline; returns NULL at end of file
+char* readLine(FILE* file) {
+    int size = 128, len = 0, ch;
+    char* line = (char*)malloc(size);
+    if (line == NULL) return NULL;
+
+    while ((ch = fgetc(file)) != EOF && ch != '\n') {
+        if (len + 1 >= size) { // Grow the buffer when full
+            size *= 2;
+            char* bigger = (char*)realloc(line, size);
+            if (bigger == NULL) {
+                free(line);
+                return NULL;
+            }
+            line = bigger;
+        }
+        line[len++] = (char)ch;
+    }
+    if (ch == EOF && len == 0) {
+        free(line);
+        return NULL;
+    }
+    if (len > 0 && line[len - 1] == '\r') len--; // Accept Windows line endings
+    line[len] = '\0';
+    return line;
+}
+
+// Compares every pair in a file; each line holds format1, expression1, format2 and expression2 separated by tabs
+// Returns the exit code: limit if any line exceeded a limit, otherwise invalid if any line was invalid,
+// otherwise different if any pair differed
+int compareBatch(const char* filename, int commutative) {
+    FILE* file = fopen(filename, "r");
+    if (file == NULL) {
+        printf("Error: Cannot open file '%s'.\n", filename);
+        return INVALID_EXIT_CODE;
+    }
+
+    int lineNumber = 0, failed = 0, different = 0, limited = 0;
+    char* line;
+    while ((line = readLine(file)) != NULL) {
+        lineNumber++;
+        if (line[0] == '\0') { // Skip blank lines
+            free(line);
+            continue;
+        }
+
+        // Split the line into its four fields
+        char* fields[4];
+        int count = 0;
+        char* cursor = line;
+        while (count < 4) {
+            fields[count++] = cursor;
+            cursor = strchr(cursor, '\t');
+            if (cursor == NULL) break;
+            *cursor++ = '\0';
+        }
+
+        printf("%d: ", lineNumber);
+        if (count != 4 || cursor != NULL) {
+            printf("Error: Expected 4 tab-separated fields.\n");
+            failed = 1;
+        } else {
+            int result = compareExpressions(fields[0], fields[1], fields[2], fields[3], commutative);
+            if (result == -2) limited = 1; // Skip the line and carry on
+            else if (result < 0) failed = 1;
+            else if (result == 0) different = 1;
+        }
+        free(line);
+    }
+
+    fclose(file);
+    if (limited) return LIMIT_EXIT_CODE;
+    if (failed) return INVALID_EXIT_CODE;
+    return different ? DIFFERENT_EXIT_CODE : 0;
+}
+
+// Simplifies the tree and reports node counts before and after on standard error
+Node* simplifyWithStats(Node* root) {
+    int operands = 0, operators = 0, mayFail = 0;
+    countNodes(root, &operands, &operators);
+    int before = operands + operators;
+    root = simplify_Tree(root, &mayFail);
+    operands = operators = 0;
+    countNodes(root, &operands, &operators);
+    fprintf(stderr, "Stats: %d nodes before simplification, %d after.\n", before, operands + operators);
+    return root;
+}
+
+// Records the hash of every subtree of a hashed tree; returns 0 if memory runs out
+int addIndexEntries(Node* root, unsigned long long id, IndexEntry** entries, long* count, long* capacity) {
+    if (root == NULL) return 1;
+    checkTime();
+    if (*count == *capacity) { // Grow the entry array when full
+        long size = *capacity ? *capacity * 2 : 1024;
+        IndexEntry* bigger = (IndexEntry*)realloc(*entries, size * sizeof(IndexEntry));
+        if (bigger == NULL) return 0;
+        *entries = bigger;
+        *capacity = size;
+    }
+    (*entries)[*count].hash = root->hash;
+    (*entries)[*count].id = id;
+    (*count)++;
+    return addIndexEntries(root->left, id, entries, count, capacity) &&
+           addIndexEntries(root->right, id, entries, count, capacity);
+}
+
+// Orders index entries by hash, then by expression id
+int compareIndexEntries(const void* a, const void* b) {
+    const IndexEntry* x = (const IndexEntry*)a;
+    const IndexEntry* y = (const IndexEntry*)b;
+    if (x->hash != y->hash) return x->hash < y->hash ? -1 : 1;
+    if (x->id != y->id) return x->id < y->id ? -1 : 1;
+    return 0;
+}
+
+// Parses one corpus expression and records the hash of each of its subtrees
+// Returns 1 if indexed, 0 if invalid, -1 if memory runs out, -2 if a limit is exceeded
+int indexExpression(const char* format, char* expression, unsigned long long id, int commutative,
+                    IndexEntry** entries, long* count, long* capacity) {
+    long first = *count; // Entries before this expression
+    if (setjmp(budgetExit)) {
+        releaseBudget();
+        *count = first; // Drop the entries of the abandoned expression
+        return -2;
+    }
+    startBudget(expression);
+    Node* root = expression_to_tree(format, expression);
+    if (root == NULL) return 0;
+
+    hash_Tree(root, commutative);
+    int added = addIndexEntries(root, id, entries, count, capacity);
+    freeTree(root, format);
+    return added ? 1 : -1;
+}
+
+// Parses each corpus line once and writes the hash of every subtree to a sorted index file
+// Each corpus line holds a format and an expression separated by a tab; its line number is its id
+int buildIndex(const char* corpusFile, const char* indexFile, int commutative) {
+    FILE* corpus = fopen(corpusFile, "r");
+    if (corpus == NULL) {
+        printf("Error: Cannot open file '%s'.\n", corpusFile);
+        return 1;
+    }
+
+    IndexEntry* entries = NULL;
+    long count = 0, capacity = 0;
+    int lineNumber = 0, indexed = 0, failed = 0, limited = 0;
+    char* line;
+    while ((line = readLine(corpus)) != NULL) {
+        lineNumber++;
+        char* expression = strchr(line, '\t');
+        if (line[0] == '\0') { // Skip blank lines
+            free(line);
+            continue;
+        } else if (expression == NULL) {
+            printf("%d: Error: Expected a format and an expression separated by a tab.\n", lineNumber);
+            failed = 1;
+            free(line);
+            continue;
+        }
+        *expression++ = '\0';
+
+        if (!isValidFormat(line)) {
+            printf("%d: Error: Invalid format specifier '%s'.\n", lineNumber, line);
+            failed = 1;
+            free(line);
+            continue;
+        }
+
+        int result = indexExpression(line, expression, lineNumber, commutative, &entries, &count, &capacity);
+        free(line);
+        if (result == 1) {
+            indexed++;
+        } else if (result == 0) { // The builder has already printed the reason
+            printf("%d: Skipped.\n", lineNumber);
+            failed = 1;
+        } else if (result == -2) { // Skip the line and carry on
+            printf("%d: Error: Resource limit exceeded - %s.\n", lineNumber, limitReason);
+            limited = 1;
+        } else {
+            printf("Error: Memory allocation failure.\n");
+            free(entries);
+            fclose(corpus);
+            return 1;
+        }
+    }
+    fclose(corpus);
+
+    // Sort by hash and drop repeated subtrees within the same expression
+    qsort(entries, count, sizeof(IndexEntry), compareIndexEntries);
+    long unique = 0;
+    for (long i = 0; i < count; i++) {
+        if (unique == 0 || compareIndexEntries(&entries[unique - 1], &entries[i]) != 0)
+            entries[unique++] = entries[i];
+    }
+
+    FILE* index = fopen(indexFile, "wb");
+    if (index == NULL) {
+        printf("Error: Cannot create file '%s'.\n", indexFile);
+        free(entries);
+        return 1;
+    }
+    IndexHeader header = {{'N', 'C', 'I', 'X'}, (unsigned int)commutative, (unsigned long long)unique};
+    int written = fwrite(&header, sizeof header, 1, index) == 1 &&
+                  (unique == 0 || fwrite(entries, sizeof(IndexEntry), unique, index) == (size_t)unique);
+    written = fclose(index) == 0 && written;
+    free(entries);
+    if (!written) {
+        printf("Error: Cannot write file '%s'.\n", indexFile);
+        return 1;
+    }
+
+    printf("Indexed %d expressions (%ld subexpressions).\n", indexed, unique);
+    if (limited) return LIMIT_EXIT_CODE;
+    return failed;
+}
+
+// Prints the id of every indexed expression that contains the pattern as a subexpression
+// Binary searches the sorted entries on disk, so only O(log n) records are read
+int queryIndex(const char* indexFile, const char* format, char* pattern) {
+    if (!isValidFormat(format)) {
+        printf("Error: Invalid format specifier '%s'.\n", format);
+        printf("Hint: Use 'infix', 'prefix', or 'postfix'.\n");
+        return 1;
+    }
+
+    FILE* index = fopen(indexFile, "rb");
+    if (index == NULL) {
+        printf("Error: Cannot open file '%s'.\n", indexFile);
+        return 1;
+    }
+    IndexHeader header;
+    if (fread(&header, sizeof header, 1, index) != 1 || memcmp(header.magic, "NCIX", 4) != 0) {
+        printf("Error: '%s' is not an index file.\n", indexFile);
+        fclose(index);
+        return 1;
+    }
+
+    // Hash the pattern the same way the corpus was hashed
+    if (setjmp(budgetExit)) {
+        printf("Error: Resource limit exceeded - %s.\n", limitReason);
+        releaseBudget();
+        fclose(index);
+        return LIMIT_EXIT_CODE;
+    }
+    startBudget(pattern);
+    Node* root = expression_to_tree(format, pattern);
+    if (root == NULL) {
+        fclose(index);
+        return 1;
+    }
+    unsigned long long target = hash_Tree(root, header.commutative);
+    freeTree(root, format);
+
+    // Find the first entry with the pattern hash
+    long long low = 0, high = (long long)header.count;
+    IndexEntry entry;
+    while (low < high) {
+        long long mid = low + (high - low) / 2;
+        fseek64(index, (long long)sizeof header + mid * (long long)sizeof(IndexEntry), SEEK_SET);
+        if (fread(&entry, sizeof entry, 1, index) != 1) break;
+        if (entry.hash < target) low = mid + 1;
+        else high = mid;
+    }
+
+    // Matching entries are adjacent and already ordered by id
+    int matches = 0;
+    fseek64(index, (long long)sizeof header + low * (long long)sizeof(IndexEntry), SEEK_SET);
+    while (fread(&entry, sizeof entry, 1, index) == 1 && entry.hash == target) {
+        printf("%llu\n", entry.id);
+        matches++;
+    }
+    fclose(index);
+
+    if (matches == 0) printf("No matching expressions.\n");
+    return 0;
 }
 
 // Function to print help information
 void printHelp() {
     printf("Expression Notation Converter\n");
     printf("Description: Converts mathematical expressions between infix, prefix, and postfix notations.\n\n");
-    printf("Usage: notation-converter --from <input_format> --to <output_format> \"<expression>\"\n\n");
+    printf("Usage: notation-converter --from <input_format> --to <output_format> \"<expression>\" [options]\n\n");
     printf("Options:\n");
     printf("  --from <input_format>     Input format: infix, prefix, or postfix\n");
-    printf("  --to <output_format>      Output format: infix, prefix, or postfix\n");
+    printf("  --to <output_format>      Output format: infix, prefix, or postfix,\n");
+    printf("                            or a comma-separated list, e.g. infix,prefix\n");
     printf("  \"<expression>\"            Input expression (in quotes)\n");
+    printf("  --simplify                Fold constants and apply identities before output\n");
+    printf("  --compare                 Check whether two expressions are the same\n");
+    printf("  --compare-batch <file>    Compare every tab-separated pair listed in a file\n");
+    printf("  --commutative             With --compare or --index, treat A + B and B + A as equal\n");
+    printf("  --index <corpus> <index>  Index every subexpression of a corpus file\n");
+    printf("  --query <index> <format> \"<pattern>\"\n");
+    printf("                            List corpus lines containing the pattern\n");
+    printf("  --max-bytes <n>           Reject input longer than n bytes\n");
+    printf("  --max-tokens <n>          Reject input with more than n tokens\n");
+    printf("  --max-nodes <n>           Stop after allocating n nodes\n");
+    printf("  --max-depth <n>           Reject expression trees deeper than n levels\n");
+    printf("  --max-time <ms>           Stop after n milliseconds of wall-clock time\n");
     printf("  -h, --help                Show this help message\n");
     printf("  --guide                   Show detailed usage guide\n\n");
     printf("Examples:\n");
     printf("  notation-converter --from prefix --to infix \"+ 1 * 2 3\"\n");
     printf("  notation-converter --from infix --to postfix \"(1 + 2) * 3\"\n");
     printf("  notation-converter --from postfix --to prefix \"1 2 3 * +\"\n");
+    printf("  notation-converter --compare infix \"(1 + 2) * 3\" postfix \"1 2 + 3 *\"\n");
     printf("  notation-converter -h\n");
     printf("  notation-converter --help\n");
     printf("  notation-converter --guide\n");
@@ -742,14 +1804,23 @@ void printGuide() {
     printf("  infix, prefix (Polish), and postfix (Reverse Polish) notations using\n");
     printf("  expression trees.\n\n");
     printf("Command Syntax:\n");
-    printf("  notation-converter --from <input_format> --to <output_format> \"<expression>\"\n");
+    printf("  notation-converter --from <input_format> --to <output_format> \"<expression>\" [options]\n");
+    printf("  notation-converter --compare <format1> \"<expression1>\" <format2> \"<expression2>\" [--commutative]\n");
+    printf("  notation-converter --compare-batch <file> [--commutative]\n");
+    printf("  notation-converter --index <corpus_file> <index_file> [--commutative]\n");
+    printf("  notation-converter --query <index_file> <format> \"<pattern>\"\n");
     printf("  notation-converter --h\n");
     printf("  notation-converter --help\n");
     printf("  notation-converter --guide\n\n");
     printf("Command-Line Options:\n");
     printf("  --from <input_format>        Specify input format (infix, prefix, or postfix)\n");
     printf("  --to <output_format>         Specify output format (infix, prefix, or postfix)\n");
+    printf("                               or a comma-separated list of them\n");
     printf("  \"<expression>\"               Expression string enclosed in double quotes\n");
+    printf("  --simplify                   Simplify the expression tree before output\n");
+    printf("  --max-bytes, --max-tokens,   Resource limits for untrusted input\n");
+    printf("  --max-nodes, --max-depth,\n");
+    printf("  --max-time <n>\n");
     printf("  -h, --help                   Show brief usage help message\n");
     printf("  --guide                      Show this detailed program guide\n\n");
     printf("Expression Notations:\n");
@@ -769,6 +1840,49 @@ void printGuide() {
     printf("     - In-order Traversal    ->  Infix  Notation (with parentheses)\n");
     printf("     - Pre-order Traversal   ->  Prefix Notation\n");
     printf("     - Post-order Traversal  ->  Postfix Notation\n\n");
+    printf("Multiple Output Formats:\n");
+    printf("  When --to lists several formats (e.g., infix,prefix,postfix), the\n");
+    printf("  expression is validated and its tree is built only once. A single\n");
+    printf("  traversal fills every requested notation, and the results are printed\n");
+    printf("  as one record with a 'notation: expression' line per format.\n\n");
+    printf("Simplification (--simplify):\n");
+    printf("  Runs one bottom-up pass over the tree before it is traversed:\n");
+    printf("  - Constant subtrees are folded when the result is a single digit,\n");
+    printf("    e.g., 2 * 3 becomes 6.\n");
+    printf("  - Identities x + 0, 0 + x, x - 0, x * 1, 1 * x and x / 1 become x.\n");
+    printf("  - x * 0 and x - x become 0, unless x contains a division that\n");
+    printf("    could be a division by zero.\n");
+    printf("  Node counts before and after are reported on standard error.\n\n");
+    printf("Subexpression Index (--index, --query):\n");
+    printf("  --index reads a corpus file with one expression per line, written as\n");
+    printf("  a format and an expression separated by a tab. Each expression is\n");
+    printf("  parsed once, and the structural hash of every subtree is stored in a\n");
+    printf("  sorted index file. --query parses a pattern in any notation and lists\n");
+    printf("  the line numbers of the corpus expressions containing it. It searches\n");
+    printf("  the index file directly, without rescanning the corpus.\n\n");
+    printf("Resource Limits:\n");
+    printf("  Each expression can be limited in input bytes, tokens, allocated\n");
+    printf("  nodes, tree depth, and wall-clock time in milliseconds. Limits are\n");
+    printf("  off unless given, and apply to every expression in --compare,\n");
+    printf("  --compare-batch, --index and --query. An expression that exceeds a\n");
+    printf("  limit is abandoned with an error. Batch and index runs skip that line\n");
+    printf("  and carry on. The exit code is then 3 (see Exit Codes).\n\n");
+    printf("Equivalence Checking (--compare, --compare-batch):\n");
+    printf("  Both expressions are parsed into trees and a structural hash is\n");
+    printf("  computed bottom-up for every subtree, so spacing and parentheses do\n");
+    printf("  not matter. The result is 'Equal', or 'Different' followed by the\n");
+    printf("  first subtrees that differ. With --commutative, the operands of\n");
+    printf("  + and * may appear in either order.\n");
+    printf("  A batch file holds one pair per line as four tab-separated fields:\n");
+    printf("  format1, expression1, format2, expression2.\n\n");    printf("Exit Codes:\n");
+    printf("  Mode             0            1               2               3\n");
+    printf("  conversion       converted    invalid input   -               over a limit\n");
+    printf("  --compare        equal        different       invalid input   over a limit\n");
+    printf("  --compare-batch  all equal    a pair differs  a line invalid  a line over a limit\n");
+    printf("  --index          all indexed  a line invalid  -               a line over a limit\n");
+    printf("  --query          searched     invalid input   -               over a limit\n");
+    printf("  Invalid arguments and unreadable files count as invalid input. A\n");
+    printf("  batch or index run with several outcomes returns the highest code.\n\n");
     printf("Input Requirements:\n");
     printf("  - Operands must be single-digit numbers (0-9) or letters of the\n");
     printf("    alphabet (A-Z and a-z).\n");
@@ -785,6 +1899,16 @@ void printGuide() {
     printf("  Convert postfix to prefix:\n");
     printf("    $ notation-converter --from postfix --to prefix \"A B C * +\"\n");
     printf("    Output: + A * B C\n\n");
+    printf("  Simplify while converting:\n");
+    printf("    $ notation-converter --from infix --to infix \"(1 + 1) * (A - 0)\" --simplify\n");
+    printf("    Output: (2 * A)\n\n");
+    printf("  Convert to several notations at once:\n");
+    printf("    $ notation-converter --from postfix --to infix,prefix \"A B + C *\"\n");
+    printf("    Output: infix: ((A + B) * C)\n");
+    printf("            prefix: * + A B C\n\n");
+    printf("  Compare two notations:\n");
+    printf("    $ notation-converter --compare infix \"(A + B) * C\" prefix \"* + B A C\" --commutative\n");
+    printf("    Output: Equal\n\n");
     printf("Error Handling:\n");
     printf("  The utility will detect and report errors such as:\n");
     printf("  - Missing or invalid arguments\n");